@@ -24,6 +24,8 @@ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWA
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
 //=================================================================================================
 // DIMACS Parser from MiniSat-C v1.14.1:
@@ -88,8 +90,27 @@ static lbool parse_DIMACS_main(char* in, solver* s) {
         skipWhitespace(&in);
         if (*in == 0)
             break;
-        else if (*in == 'c' || *in == 'p')
+        else if (*in == 'c')
             skipLine(&in);
+        else if (*in == 'p'){
+            // "p cnf <vars> <clauses>": declared variables count even if no clause uses them
+            in++;
+            skipWhitespace(&in);
+            while (*in >= 'a' && *in <= 'z') in++;
+            solver_setnvars(s, parseInt(&in));
+            skipLine(&in);
+        }
+        else if (*in == 'x'){
+            // "x1 -2 3 0": XOR constraint
+            lit* begin;
+            in++;
+            readClause(&in, &lits);
+            begin = veci_begin(&lits);
+            if (!solver_addxor(s, begin, begin+veci_size(&lits))){
+                veci_delete(&lits);
+                return l_False;
+            }
+        }
         else{
             lit* begin;
             readClause(&in, &lits);
@@ -117,38 +138,171 @@ static lbool parse_DIMACS(FILE * in, solver* s) {
 //=================================================================================================
 
 
+static volatile sig_atomic_t checkpoint_request = 0;
+
+// SIGUSR1 asks for a snapshot, SIGTERM and SIGINT for a snapshot and a clean stop
+static void checkpoint_handler(int sig)
+{
+   checkpoint_request = (sig == SIGUSR1) ? ckpt_Save : ckpt_Stop;
+}
+
 int main(int argc, char** argv)
 {
-   solver* s = solver_new();
+   solver* s;
    lbool st;
    FILE* in;
    FILE* out;
+   char* infile   = NULL;
+   bool  split    = true;                            // solve independent components separately
+   int   nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+   int   enumerate = enum_None;
+   char* project  = NULL;                            // comma separated DIMACS variables
+   char* checkpoint = NULL;                          // snapshot file
+   int   interval = 600;                             // seconds between periodic snapshots
+   char* resume   = NULL;                            // snapshot to continue from
+   bool  verify   = false;                           // check the model against the input
+   bool  findxors = true;                            // look for XOR constraints in the clauses
+   int   bad      = -1;                              // first clause the model falsifies
+   int   status;
+   int   i;
 
-   if (argc != 2)
-     fprintf(stderr, "ERROR! Not enough command line arguments.\n"),
-     exit(1);
-   out = fopen("SimpleSATc.out","a");
-   in = fopen(argv[1], "rb");
-   if (in == NULL)
-     fprintf(stderr, "ERROR! Could not open file: %s\n", argc == 1 ? "<stdin>" : argv[1]),
+   for (i = 1; i < argc; i++){
+     if (strncmp(argv[i], "--threads=", 10) == 0)
+       nthreads = atoi(argv[i] + 10);
+     else if (strcmp(argv[i], "--no-split") == 0)
+       split = false;
+     else if (strcmp(argv[i], "--all") == 0)
+       enumerate = enum_All;
+     else if (strcmp(argv[i], "--count") == 0)
+       enumerate = enum_Count;
+     else if (strncmp(argv[i], "--project=", 10) == 0)
+       project = argv[i] + 10;
+     else if (strncmp(argv[i], "--checkpoint=", 13) == 0)
+       checkpoint = argv[i] + 13;
+     else if (strncmp(argv[i], "--checkpoint-interval=", 22) == 0)
+       interval = atoi(argv[i] + 22);
+     else if (strncmp(argv[i], "--resume=", 9) == 0)
+       resume = argv[i] + 9;
+     else if (strcmp(argv[i], "--verify") == 0)
+       verify = true;
+     else if (strcmp(argv[i], "--no-xor") == 0)
+       findxors = false;
+     else if (argv[i][0] == '-' && argv[i][1] == '-')
+       fprintf(stderr, "ERROR! Unknown option: %s\n", argv[i]),
+       exit(1);
+     else
+       infile = argv[i];
+   }
+
+   if (verify && enumerate != enum_None)
+     fprintf(stderr, "ERROR! --verify cannot be combined with --all or --count.\n"),
      exit(1);
-   st = parse_DIMACS(in, s);
-   fclose(in);
 
-   if (st == l_False){
-     solver_delete(s);
-     printf("Trivial problem\nUNSATISFIABLE\n");
-     exit(20);
+   if (resume != NULL){
+     // the snapshot holds the whole problem and the enumeration settings
+     if (enumerate != enum_None || project != NULL)
+       fprintf(stderr, "ERROR! --all, --count and --project cannot be changed when resuming.\n"),
+       exit(1);
+     s = solver_resume(resume);
+     if (s == NULL)
+       fprintf(stderr, "ERROR! Could not resume from snapshot: %s\n", resume),
+       exit(1);
+     if (verify && s->enumerate != enum_None)
+       fprintf(stderr, "ERROR! --verify cannot be combined with an --all or --count snapshot.\n"),
+       exit(1);
+     if (checkpoint == NULL) checkpoint = resume;
+     infile = s->input_file;
+     if (verify) solver_keeporiginal(s); // the clauses in a snapshot are the original ones
+   }
+   else {
+     if (infile == NULL)
+       fprintf(stderr, "ERROR! Not enough command line arguments.\n"),
+       exit(1);
+     s = solver_new();
+     s->input_file = strdup(infile);
+     if (verify) solver_keeporiginal(s);
+     in = fopen(infile, "rb");
+     if (in == NULL)
+       fprintf(stderr, "ERROR! Could not open file: %s\n", infile),
+       exit(1);
+     st = parse_DIMACS(in, s);
+     fclose(in);
+
+     if (st == l_False){
+       solver_delete(s);
+       printf("Trivial problem\nUNSATISFIABLE\n");
+       exit(20);
+     }
+
+     if (findxors)
+       solver_findxors(s);
+
+     if (project != NULL){
+       char* p = project;
+       while (*p != 0){
+         int var = (int)strtol(p, &p, 10);
+         if (var <= 0 || (*p != ',' && *p != 0))
+           fprintf(stderr, "ERROR! Bad variable list: %s\n", project),
+           exit(1);
+         if (!solver_project(s, var-1))
+           fprintf(stderr, "ERROR! No variable %d in the formula (--project).\n", var),
+           exit(1);
+         if (*p == ',') p++;
+       }
+     }
+     s->enumerate = enumerate;
    }
 
-   st = solver_solve(s);
+   if (checkpoint != NULL){
+     s->checkpoint_file    = checkpoint;
+     s->checkpoint_every   = interval;
+     s->checkpoint_request = &checkpoint_request;
+     signal(SIGUSR1, checkpoint_handler);
+     signal(SIGTERM, checkpoint_handler);
+     signal(SIGINT,  checkpoint_handler);
+     split = false; // a snapshot covers one search, not several components
+   }
 
+   out = fopen("SimpleSATc.out","a");
    fprintf(out,"################################# SimpleSATc #################################\n");
-   fprintf(out,"Input file: %s\n",argv[1]);
-   if(s->satisfied) {
+   if (infile != NULL)
+     fprintf(out,"Input file: %s\n",infile);
+   if (resume != NULL)
+     fprintf(out,"Resumed from: %s\n",resume);
+
+   if (s->enumerate != enum_None){
+     // models are streamed to the output while solving
+     s->model_out = out;
+     st = solver_solve(s);
+   }
+   else
+     st = split ? solver_solve_components(s, nthreads) : solver_solve(s);
+
+   if(s->stopped) {
+      fprintf(out,"Result: STOPPED (search state saved to %s)\n\n\n\n\n\n", checkpoint);
+   }
+
+   else if(s->enumerate != enum_None) {
+      fprintf(out,"Result: %s\n", s->satisfied ? "SATISFIABLE" : "UNSATISFIABLE");
+      fprintf(out,"Number of models: ");
+      printcount(s,out);
+      fprintf(out, "\n\n\n\n\n\n");
+   }
+
+   else if(s->satisfied) {
       fprintf(out,"Result: SATISFIABLE\n");
       fprintf(out,"Satisfying Solution:\n");
       printsolution(s,out);
+      if (verify){
+         bad = solver_verify(s, nthreads);
+         if (bad == -1)
+            fprintf(out,"\nVerification: PASSED");
+         else {
+            fprintf(out,"\nVerification: FAILED, clause not satisfied: ");
+            printoriginal(s, bad, out);
+            fprintf(stderr, "ERROR! The model does not satisfy the input.\n");
+         }
+      }
       fprintf(out, "\n\n\n\n\n\n");
    }
 
@@ -156,7 +310,8 @@ int main(int argc, char** argv)
       fprintf(out,"Result: UNSATISFIABLE\n\n\n\n\n\n");
    }
 
+   status = s->stopped ? 3 : bad == -1 ? 0 : 1; // 3: stopped, resume from the snapshot
    fclose(out);
    solver_delete(s);
-   return 0;
+   return status;
 }
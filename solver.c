@@ -21,7 +21,13 @@ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWA
 **************************************************************************************************/
 
 #include <stdio.h>
+#include <stdint.h>
+#include <string.h>
 #include <assert.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/wait.h>
 #include "solver.h"
 
 
@@ -99,16 +105,11 @@ static clause* clause_new(solver* s, lit* begin, lit* end)
     size           = end - begin;
     c              = (clause*)malloc(sizeof(clause) + sizeof(lit) * size);
 
-    for (i = 0; i < size; i++)
+    for (i = 0; i < size; i++){
         c->lits[i] = begin[i];
-
-    assert(begin[0] >= 0);
-    assert(begin[0] < s->size*2);
-    assert(begin[1] >= 0);
-    assert(begin[1] < s->size*2);
-
-    assert(lit_neg(begin[0]) < s->size*2);
-    assert(lit_neg(begin[1]) < s->size*2);
+        assert(begin[i] >= 0);
+        assert(begin[i] < s->size*2);
+    }
 
     c->size = size;
     c->level_sat = -1;  // -1 means 'clause not yet satisfied'
@@ -121,6 +122,7 @@ static clause* clause_new(solver* s, lit* begin, lit* end)
 void solver_setnvars(solver* s,int n)
 {
     int var;
+    int old_cap = s->cap;
 
     if (s->cap < n*2){
 
@@ -131,14 +133,17 @@ void solver_setnvars(solver* s,int n)
         s->levels    = (int*)    realloc(s->levels,   sizeof(int)*s->cap);
         s->counts    = (int*)    realloc(s->counts,   sizeof(int)*s->cap);
         s->level_choice = (lit*) realloc(s->level_choice, sizeof(lit)*s->cap);
+        s->proj      = (bool*)   realloc(s->proj,     sizeof(bool)*s->cap);
     }
 
-    for (var = 0; var < s->cap; var++){
+    // only the newly allocated slots need initializing; the rest are already in use
+    for (var = old_cap; var < s->cap; var++){
         s->decisions    [var] = false;
         s->assigns      [var] = l_Undef;
         s->levels       [var] = -1;
         s->counts       [var] = 0;
         s->level_choice [var] = -1;
+        s->proj         [var] = !s->projected;
     }
 
     s->size = n > s->size ? n : s->size;
@@ -153,6 +158,521 @@ void printsolution(solver* s, FILE* out) {
    }
 }
 
+// Restricts model enumeration to the given variable. The first call drops all other variables
+// from the projection (by default every variable is enumerated). Returns false if the formula
+// has no such variable.
+bool solver_project(solver* s, int var)
+{
+   int i;
+   if (var < 0 || var >= s->size) return false;
+   if (!s->projected){
+      s->projected = true;
+      for (i = 0; i < s->cap; i++) s->proj[i] = false;
+   }
+   s->proj[var] = true;
+   return true;
+}
+
+// Adds 2^k to the model counter (a little-endian array of 32-bit words).
+static void count_add_pow2(veci* cnt, int k)
+{
+   int      i   = k >> 5;
+   unsigned add = 1u << (k & 31);
+   unsigned* w;
+
+   while (veci_size(cnt) <= i) veci_push(cnt, 0);
+   for (;;){
+      w = (unsigned*)veci_begin(cnt);
+      w[i] += add;
+      if (w[i] >= add) break; // no carry
+      add = 1;
+      if (++i == veci_size(cnt)) veci_push(cnt, 0);
+   }
+}
+
+void printcount(solver* s, FILE* out)
+{
+   // repeatedly divide a copy of the counter by 10^9, the remainders are the decimal digits
+   int       n      = veci_size(&s->nmodels);
+   unsigned* w      = (unsigned*)malloc(sizeof(unsigned)*(n+1));
+   unsigned* chunks = (unsigned*)malloc(sizeof(unsigned)*(n*32/29+2));
+   int       nchunks = 0;
+   int       i;
+
+   for (i = 0; i < n; i++) w[i] = (unsigned)veci_begin(&s->nmodels)[i];
+   while (n > 0 && w[n-1] == 0) n--;
+   while (n > 0){
+      unsigned long long rem = 0;
+      for (i = n-1; i >= 0; i--){
+         unsigned long long cur = (rem << 32) | w[i];
+         w[i] = (unsigned)(cur / 1000000000u);
+         rem  = cur % 1000000000u;
+      }
+      chunks[nchunks++] = (unsigned)rem;
+      while (n > 0 && w[n-1] == 0) n--;
+   }
+
+   if (nchunks == 0) fprintf(out, "0");
+   else{
+      fprintf(out, "%u", chunks[nchunks-1]);
+      for (i = nchunks-2; i >= 0; i--) fprintf(out, "%09u", chunks[i]);
+   }
+   free(w);
+   free(chunks);
+}
+
+
+//=================================================================================================
+// XOR constraints:
+//
+// Each constraint is stored as its variables plus the parity they must add up to ('x1 -2 3 0' in
+// the input is x1 + x2 + x3 = 0 (mod 2)). During the search all XOR constraints together are kept
+// as one bit-packed matrix in reduced row echelon form over the unassigned variables (Gauss-Jordan
+// elimination). Assigned variables are substituted into the matrix as they are found; a row left
+// without variables but with parity 1 is a conflict, a row with a single variable implies it.
+// Because the form is fully reduced, every literal implied by the XOR constraints together shows
+// up this way, not just those implied by a single constraint. Every change made to the matrix at a
+// level is logged on an undo trail, which backtracking replays in reverse.
+
+#define XOR_MIN_FIND   3          // smallest XOR worth finding in the clauses (size 2 is just x = y)
+#define XOR_MAX_FIND   7          // largest: a k-variable XOR takes 2^(k-1) clauses
+#define XOR_MAX_BITS   (1 << 22)  // found XORs are only used if the matrix stays below this size
+
+struct gauss_t
+{
+   int       ncols;       // columns: one per variable occurring in an XOR constraint
+   int       nrows;
+   int       words;       // 64-bit words per row: one bit per column, then the parity bit
+   int*      col_var;     // variable of each column
+   uint64_t* m;           // the rows
+   uint64_t* live;        // columns of unassigned variables (one row worth of words)
+   int*      pivot;       // pivot column of each row, -1 if the row has no variables left
+   veci      trail;       // undo log: (undo_Xor, dst, src), (undo_Flip, row, col), (undo_Pivot, row, old)
+   veci      trail_lim;   // (level, trail size) for each level that changed the matrix
+};
+
+enum { undo_Xor, undo_Flip, undo_Pivot };
+
+static inline uint64_t* gauss_row(gauss* g, int r)    { return g->m + (size_t)r*g->words; }
+static inline int       bit_get  (uint64_t* w, int i) { return (int)(w[i >> 6] >> (i & 63)) & 1; }
+static inline void      bit_flip (uint64_t* w, int i) { w[i >> 6] ^= (uint64_t)1 << (i & 63); }
+
+static inline void row_xor(gauss* g, uint64_t* dst, uint64_t* src)
+{
+   int i;
+   for (i = 0; i < g->words; i++) dst[i] ^= src[i];
+}
+
+// Changes are only logged once a level has been opened by gauss_save(), so building the matrix
+// leaves nothing on the trail.
+static inline void gauss_log(gauss* g, int what, int a, int b)
+{
+   if (veci_size(&g->trail_lim) == 0) return;
+   veci_push(&g->trail, what);
+   veci_push(&g->trail, a);
+   veci_push(&g->trail, b);
+}
+
+// Row 'dst' ^= row 'src'.
+static inline void gauss_xor(gauss* g, int dst, int src)
+{
+   row_xor(g, gauss_row(g, dst), gauss_row(g, src));
+   gauss_log(g, undo_Xor, dst, src);
+}
+
+// Flips column 'c' (or the parity bit) of row 'r'; row -1 is the live columns.
+static inline void gauss_flip(gauss* g, int r, int c)
+{
+   bit_flip(r == -1 ? g->live : gauss_row(g, r), c);
+   gauss_log(g, undo_Flip, r, c);
+}
+
+static inline void gauss_set_pivot(gauss* g, int r, int c)
+{
+   gauss_log(g, undo_Pivot, r, g->pivot[r]);
+   g->pivot[r] = c;
+}
+
+// Number of variables in a row.
+static int row_nvars(gauss* g, uint64_t* row)
+{
+   int i, n = -bit_get(row, g->ncols); // the parity bit is not a variable
+   for (i = 0; i < g->words; i++)
+      n += __builtin_popcountll(row[i]);
+   return n;
+}
+
+// First column in a row, -1 if there is none.
+static int row_first(gauss* g, uint64_t* row)
+{
+   int i;
+   for (i = 0; i < g->words; i++){
+      uint64_t w = row[i];
+      if (i == g->ncols >> 6) w &= ~((uint64_t)1 << (g->ncols & 63));
+      if (w != 0) return i*64 + __builtin_ctzll(w);
+   }
+   return -1;
+}
+
+// Makes column 'c' the pivot of row 'r', removing it from every other row.
+static void gauss_eliminate(gauss* g, int r, int c)
+{
+   int i;
+   gauss_set_pivot(g, r, c);
+   for (i = 0; i < g->nrows; i++)
+      if (i != r && bit_get(gauss_row(g, i), c))
+         gauss_xor(g, i, r);
+}
+
+// Level at which variable 'v' was assigned.
+static inline int var_level(solver* s, int v)
+{
+   lit l = toLit(v);
+   return s->assigns[l] == l_True ? s->levels[l] : s->levels[lit_neg(l)];
+}
+
+static void gauss_delete(gauss* g)
+{
+   veci_delete(&g->trail);
+   veci_delete(&g->trail_lim);
+   free(g->col_var);
+   free(g->m);
+   free(g);
+}
+
+// Opens 'level' on the trail before its first change to the matrix.
+static void gauss_save(gauss* g, int level)
+{
+   int n = veci_size(&g->trail_lim);
+
+   if (n > 0 && veci_begin(&g->trail_lim)[n-2] == level) return;
+   veci_push(&g->trail_lim, level);
+   veci_push(&g->trail_lim, veci_size(&g->trail));
+}
+
+// Undoes the changes made at 'level', which is being backtracked over. The trail is replayed
+// newest first, so the source row of each logged XOR is back in the state it was XORed in with.
+static void gauss_backtrack(gauss* g, int level)
+{
+   int  n = veci_size(&g->trail_lim);
+   int* t = veci_begin(&g->trail);
+   int  i;
+
+   if (n == 0 || veci_begin(&g->trail_lim)[n-2] != level) return;
+   for (i = veci_size(&g->trail) - 3; i >= veci_begin(&g->trail_lim)[n-1]; i -= 3){
+      if      (t[i] == undo_Xor)  row_xor(g, gauss_row(g, t[i+1]), gauss_row(g, t[i+2]));
+      else if (t[i] == undo_Flip) bit_flip(t[i+1] == -1 ? g->live : gauss_row(g, t[i+1]), t[i+2]);
+      else                        g->pivot[t[i+1]] = t[i+2];
+   }
+   veci_resize(&g->trail, veci_begin(&g->trail_lim)[n-1]);
+   veci_resize(&g->trail_lim, n-2);
+}
+
+// Substitutes the variables assigned at or below 'level' into the matrix, and restores the
+// reduced row echelon form for the rows that lost their pivot.
+static void gauss_sync(solver* s, int level)
+{
+   gauss* g       = s->gauss;
+   bool   changed = false;
+   bool   repivot = false;
+   int    c, r;
+
+   for (c = 0; c < g->ncols; c++){
+      int v = g->col_var[c];
+      if (!bit_get(g->live, c) || s->assigns[toLit(v)] == l_Undef || var_level(s, v) > level)
+         continue;
+      if (!changed){
+         gauss_save(g, level);
+         changed = true;
+      }
+      gauss_flip(g, -1, c);
+      for (r = 0; r < g->nrows; r++){
+         if (!bit_get(gauss_row(g, r), c)) continue;
+         gauss_flip(g, r, c);
+         if (s->assigns[toLit(v)] == l_True) gauss_flip(g, r, g->ncols);
+         if (g->pivot[r] == c){
+            gauss_set_pivot(g, r, -2); // needs a new pivot
+            repivot = true;
+         }
+      }
+   }
+
+   // The other columns of a row are never pivots of other rows, so any of them will do.
+   for (r = 0; repivot && r < g->nrows; r++){
+      if (g->pivot[r] != -2) continue;
+      c = row_first(g, gauss_row(g, r));
+      if (c == -1) gauss_set_pivot(g, r, -1);
+      else         gauss_eliminate(g, r, c);
+   }
+}
+
+// Brings the matrix up to date with the current assignment and collects the literals it implies.
+// Returns false on conflict. '*solved' is set if no row has variables left.
+static bool gauss_propagate(solver* s, veci* implied, bool* solved)
+{
+   gauss* g = s->gauss;
+   int    r;
+
+   gauss_sync(s, s->cur_level);
+   veci_resize(implied, 0);
+   *solved = true;
+   for (r = 0; r < g->nrows; r++){
+      uint64_t* row = gauss_row(g, r);
+      if (g->pivot[r] == -1){
+         if (bit_get(row, g->ncols)) return false; // 0 = 1
+         continue;
+      }
+      *solved = false;
+      if (row_nvars(g, row) == 1){
+         lit l = toLit(g->col_var[g->pivot[r]]);
+         veci_push(implied, bit_get(row, g->ncols) ? l : lit_neg(l));
+      }
+   }
+   return true;
+}
+
+// Picks an unassigned variable that still occurs in the matrix (only from the projection if
+// 'proj_only'). Returns -1 if there is none.
+static lit gauss_pick(solver* s, bool proj_only)
+{
+   gauss* g = s->gauss;
+   int    r, c;
+
+   for (r = 0; r < g->nrows; r++){
+      uint64_t* row = gauss_row(g, r);
+      if (g->pivot[r] < 0) continue;
+      for (c = 0; c < g->ncols; c++)
+         if (bit_get(row, c) && (!proj_only || s->proj[g->col_var[c]]))
+            return toLit(g->col_var[c]);
+   }
+   return -1;
+}
+
+// Builds the matrix from the XOR constraints. Returns false if they contradict each other.
+// When resuming a search, the matrix (and its trail) are brought up to date level by level.
+static bool gauss_init(solver* s)
+{
+   gauss* g;
+   int*   var_col;
+   int*   vars = veci_begin(&s->xor_vars);
+   int*   ends = veci_begin(&s->xor_ends);
+   int    nxors = veci_size(&s->xor_ends);
+   int    i, j, r, c, level;
+
+   g = (gauss*)malloc(sizeof(gauss));
+   veci_new(&g->trail);
+   veci_new(&g->trail_lim);
+
+   var_col    = (int*)malloc(sizeof(int)*s->size);
+   g->col_var = (int*)malloc(sizeof(int)*s->size);
+   g->ncols   = 0;
+   for (i = 0; i < s->size; i++) var_col[i] = -1;
+   for (i = 0; i < veci_size(&s->xor_vars); i++)
+      if (var_col[vars[i]] == -1){
+         var_col[vars[i]] = g->ncols;
+         g->col_var[g->ncols++] = vars[i];
+      }
+
+   g->nrows = nxors;
+   g->words = (g->ncols >> 6) + 1;
+   g->m     = (uint64_t*)calloc(sizeof(uint64_t)*g->words*(g->nrows+1) + sizeof(int)*g->nrows, 1);
+   g->live  = g->m + (size_t)g->words*g->nrows;
+   g->pivot = (int*)(g->live + g->words);
+
+   for (i = 0; i < nxors; i++){
+      uint64_t* row = gauss_row(g, i);
+      for (j = i == 0 ? 0 : ends[i-1]; j < ends[i]; j++)
+         bit_flip(row, var_col[vars[j]]);
+      if (veci_begin(&s->xor_rhs)[i]) bit_flip(row, g->ncols);
+   }
+   free(var_col);
+
+   // Gauss-Jordan elimination
+   r = 0;
+   for (c = 0; c < g->ncols && r < g->nrows; c++){
+      for (i = r; i < g->nrows && !bit_get(gauss_row(g, i), c); i++);
+      if (i == g->nrows) continue;
+      if (i != r){
+         row_xor(g, gauss_row(g, r), gauss_row(g, i)); // swap rows r and i
+         row_xor(g, gauss_row(g, i), gauss_row(g, r));
+         row_xor(g, gauss_row(g, r), gauss_row(g, i));
+      }
+      gauss_eliminate(g, r++, c);
+   }
+
+   // the rows from r on have no variables left: 0 = 0 or 0 = 1
+   for (i = r; i < g->nrows; i++)
+      if (bit_get(gauss_row(g, i), g->ncols)){
+         gauss_delete(g);
+         return false;
+      }
+
+   if (r == 0){
+      gauss_delete(g);  // nothing left to enforce
+      return true;
+   }
+
+   // drop the empty rows (the block shrinks, so the live columns and pivots move up)
+   memmove(gauss_row(g, r), g->live, sizeof(uint64_t)*g->words + sizeof(int)*r);
+   g->nrows = r;
+   g->live  = g->m + (size_t)g->words*g->nrows;
+   g->pivot = (int*)(g->live + g->words);
+   for (c = 0; c < g->ncols; c++) bit_flip(g->live, c);
+
+   s->gauss = g;
+   for (level = 0; level <= s->cur_level; level++)
+      gauss_sync(s, level);
+   return true;
+}
+
+// Adds the constraint 'begin[0] XOR begin[1] XOR ...' (the literals, so negations flip the
+// parity). Returns false if the constraint can never be satisfied.
+bool solver_addxor(solver* s, lit* begin, lit* end)
+{
+    lit *i,*j;
+    int maxvar  = 0;
+    int parity  = 1;
+    int n       = 0;
+
+    // insertion sort, so that repeated variables are next to each other: x XOR x = 0
+    for (i = begin; i < end; i++){
+        lit l = *i;
+        parity ^= lit_sign(l);
+        maxvar = lit_var(l) > maxvar ? lit_var(l) : maxvar;
+        for (j = i; j > begin && *(j-1) > l; j--)
+            *j = *(j-1);
+        *j = l;
+    }
+    for (i = begin; i < end; i++){
+        if (i+1 < end && lit_var(*i) == lit_var(*(i+1))) { i++; continue; }
+        begin[n++] = lit_var(*i);
+    }
+    if (n == 0) return parity == 0;
+
+    solver_setnvars(s,maxvar+1);
+    for (i = begin; i < begin + n; i++)
+        veci_push(&s->xor_vars, *i);
+    veci_push(&s->xor_ends, veci_size(&s->xor_vars));
+    veci_push(&s->xor_rhs, parity);
+    return true;
+}
+
+// parity of the number of negative literals in a clause
+static int clause_parity(clause* c)
+{
+   int i, p = 0;
+   for (i = 0; i < clause_size(c); i++) p ^= lit_sign(c->lits[i]);
+   return p;
+}
+
+// hash of the variables of a clause (its literals are sorted, so equal sets hash alike)
+static unsigned clause_varhash(clause* c)
+{
+   unsigned h = (unsigned)clause_size(c);
+   int      i;
+   for (i = 0; i < clause_size(c); i++) h = (h ^ (unsigned)lit_var(c->lits[i])) * 0x9E3779B1u;
+   return h ^ (h >> 16);
+}
+
+// orders clauses by size, then variables, then parity
+static int xor_cmp(const void* x, const void* y)
+{
+   clause* a = *(clause**)x;
+   clause* b = *(clause**)y;
+   int     i;
+
+   if (clause_size(a) != clause_size(b)) return clause_size(a) - clause_size(b);
+   for (i = 0; i < clause_size(a); i++)
+      if (lit_var(a->lits[i]) != lit_var(b->lits[i]))
+         return lit_var(a->lits[i]) - lit_var(b->lits[i]);
+   return clause_parity(a) - clause_parity(b);
+}
+
+// Finds XOR constraints encoded as clauses: x1 XOR ... XOR xk = p takes the 2^(k-1) clauses over
+// x1..xk with an odd (p = 0) or even (p = 1) number of negations. The clauses stay; the XOR
+// constraints are added on top of them, for the matrix. Returns the number found.
+int solver_findxors(solver* s)
+{
+   clause**  cand = (clause**)malloc(sizeof(clause*)*(vecp_size(&s->clauses)+1));
+   unsigned* hash = (unsigned*)malloc(sizeof(unsigned)*(vecp_size(&s->clauses)+1));
+   uint8_t*  bucket;           // clauses per hash bucket (stops counting at 255)
+   unsigned  mask_h = 1;
+   veci      found_vars, found_ends, found_rhs;
+   char      seen[1 << XOR_MAX_FIND];
+   bool*     in_xor;
+   int       ncand = 0, ncols = 0, nfound, n, i, j, k;
+
+   // A k-variable XOR needs 2^(k-1) clauses over the same variables, so clauses are counted per
+   // hash of their variables first, and only those in a bucket that full are sorted into groups.
+   while (mask_h < (unsigned)vecp_size(&s->clauses)*2) mask_h <<= 1;
+   bucket = (uint8_t*)calloc(mask_h, 1);
+   mask_h--;
+
+   // candidates: clauses of the right size without repeated variables
+   for (i = 0; i < vecp_size(&s->clauses); i++){
+      clause* c = vecp_begin(&s->clauses)[i];
+      if (clause_size(c) < XOR_MIN_FIND || clause_size(c) > XOR_MAX_FIND) continue;
+      for (j = 1; j < clause_size(c) && lit_var(c->lits[j-1]) != lit_var(c->lits[j]); j++);
+      if (j < clause_size(c)) continue;
+      hash[ncand]   = clause_varhash(c) & mask_h;
+      cand[ncand++] = c;
+      bucket[hash[ncand-1]] += bucket[hash[ncand-1]] < 255;
+   }
+   for (i = n = 0; i < ncand; i++)   // (the first test spares most clauses another look)
+      if (bucket[hash[i]] >= 1 << (XOR_MIN_FIND-1) && bucket[hash[i]] >= 1 << (clause_size(cand[i])-1))
+         cand[n++] = cand[i];
+   ncand = n;
+   free(bucket);
+   free(hash);
+   qsort(cand, ncand, sizeof(clause*), xor_cmp);
+
+   veci_new(&found_vars);
+   veci_new(&found_ends);
+   veci_new(&found_rhs);
+   for (i = 0; i < ncand; i = j){
+      int size  = clause_size(cand[i]);
+      int count = 0;
+
+      memset(seen, 0, sizeof(seen));
+      for (j = i; j < ncand && xor_cmp(&cand[i], &cand[j]) == 0; j++){
+         int mask = 0;
+         for (k = 0; k < size; k++) mask |= lit_sign(cand[j]->lits[k]) << k;
+         count += !seen[mask];
+         seen[mask] = 1;
+      }
+      if (count == 1 << (size-1)){
+         for (k = 0; k < size; k++)
+            veci_push(&found_vars, lit_var(cand[i]->lits[k]));
+         veci_push(&found_ends, veci_size(&found_vars));
+         veci_push(&found_rhs, clause_parity(cand[i]) ^ 1);
+      }
+   }
+   free(cand);
+
+   // keep them only if the matrix stays reasonably small
+   nfound = veci_size(&found_ends);
+   in_xor = (bool*)calloc(s->size, sizeof(bool));
+   for (i = 0; i < veci_size(&s->xor_vars) + veci_size(&found_vars); i++){
+      int v = i < veci_size(&s->xor_vars) ? veci_begin(&s->xor_vars)[i]
+                                          : veci_begin(&found_vars)[i - veci_size(&s->xor_vars)];
+      if (!in_xor[v]) ncols++;
+      in_xor[v] = true;
+   }
+   free(in_xor);
+   if ((double)ncols * (veci_size(&s->xor_ends) + nfound) > XOR_MAX_BITS)
+      nfound = 0;
+
+   for (i = 0; i < nfound; i++){
+      for (j = i == 0 ? 0 : veci_begin(&found_ends)[i-1]; j < veci_begin(&found_ends)[i]; j++)
+         veci_push(&s->xor_vars, veci_begin(&found_vars)[j]);
+      veci_push(&s->xor_ends, veci_size(&s->xor_vars));
+      veci_push(&s->xor_rhs, veci_begin(&found_rhs)[i]);
+   }
+   veci_delete(&found_vars);
+   veci_delete(&found_ends);
+   veci_delete(&found_rhs);
+   return nfound;
+}
 
 //=================================================================================================
 // Solver functions
@@ -169,6 +689,7 @@ solver* solver_new(void)
    s->assigns        = 0;
    s->levels         = 0;
    s->counts         = 0;
+   s->proj           = 0;
 
    // initialize other variables
    s->size           = 0;
@@ -176,6 +697,27 @@ solver* solver_new(void)
    s->tail           = 0;
    s->cur_level      = -1;
    s->satisfied      = false;
+   s->interrupt      = 0;
+   s->enumerate      = enum_None;
+   s->model_out      = 0;
+   s->projected      = false;
+   s->proj_level     = -2;
+   veci_new(&s->nmodels);
+   s->checkpoint_file    = 0;
+   s->checkpoint_every   = 0;
+   s->checkpoint_request = 0;
+   s->checkpoint_last    = time(0);
+   s->checkpoint_ticks   = 0;
+   s->checkpoint_pid     = 0;
+   s->stopped            = false;
+   s->input_file         = 0;
+   s->keep_original      = false;
+   veci_new(&s->orig_lits);
+   veci_new(&s->orig_ends);
+   veci_new(&s->xor_vars);
+   veci_new(&s->xor_ends);
+   veci_new(&s->xor_rhs);
+   s->gauss              = 0;
 
    return s;
 
@@ -190,6 +732,14 @@ void solver_delete(solver* s)
 
     // delete vectors
     vecp_delete(&s->clauses);
+    veci_delete(&s->nmodels);
+    free(s->input_file);
+    veci_delete(&s->orig_lits);
+    veci_delete(&s->orig_ends);
+    veci_delete(&s->xor_vars);
+    veci_delete(&s->xor_ends);
+    veci_delete(&s->xor_rhs);
+    if (s->gauss != 0) gauss_delete(s->gauss);
 
     // delete arrays
     if (s->decisions != 0){
@@ -200,6 +750,7 @@ void solver_delete(solver* s)
         free(s->assigns  );
         free(s->levels   );
         free(s->counts   );
+        free(s->proj     );
     }
 
     free(s);
@@ -224,6 +775,12 @@ bool solver_addclause(solver* s, lit* begin, lit* end)
     }
     solver_setnvars(s,maxvar+1);
 
+    // keep a copy for verifying the model
+    if (s->keep_original){
+        for (i = begin; i < end; i++) veci_push(&s->orig_lits, *i);
+        veci_push(&s->orig_ends, veci_size(&s->orig_lits));
+    }
+
     // create new clause
     vecp_push(&s->clauses,clause_new(s,begin,end));
     s->tail++;  // tail == # of clauses at first.
@@ -260,15 +817,31 @@ lit make_decision(solver* s)
    if(!update_counts(s))
       fprintf(stderr, "ERROR! Failed to update literal counts at level %d\n", s->cur_level),
       exit(1);
-   maxval = -1;
+   maxval = 0;
    maxlit = -1;
+   // when enumerating a projection, all projection variables are decided on first
    for(i = 0; i < s->size*2; i++){
-      if (s->counts[i] > maxval){
+      if (s->counts[i] > maxval && s->proj[lit_var(i)]){
          maxval = s->counts[i];
          maxlit = i;
       }
    }
-   if (maxval == 0 || s->assigns[maxlit] == l_False)
+   if (maxlit == -1 && s->gauss != 0)  // all clauses satisfied, but not the XOR constraints
+      maxlit = gauss_pick(s, true);
+   if (maxlit == -1 && s->projected){
+      // Only non-projection variables are left. Remember where that part of the search starts,
+      // so that next_model() can skip other models with the same projection.
+      if (s->proj_level == -2) s->proj_level = s->cur_level;
+      for(i = 0; i < s->size*2; i++){
+         if (s->counts[i] > maxval){
+            maxval = s->counts[i];
+            maxlit = i;
+         }
+      }
+      if (maxlit == -1 && s->gauss != 0)
+         maxlit = gauss_pick(s, false);
+   }
+   if (maxlit == -1 || s->assigns[maxlit] == l_False)
       fprintf(stderr, "ERROR! make_decision failed to find a lit that exists and isn't false!\n"),
       exit(1);
 
@@ -303,12 +876,12 @@ bool propagate_decision(solver* s, lit decision, bool new_level){
             c->level_sat = s->cur_level;
             if(s->tail == 1) {
                s->tail--;
-               s->satisfied = true;
+               s->satisfied = (s->gauss == 0); // otherwise the XOR constraints have the last word
                return true;
             }
             vecp_begin(&s->clauses)[i] = vecp_begin(&s->clauses)[--s->tail];
             vecp_begin(&s->clauses)[s->tail] = c;
-            i = i--; // be sure to check the current i again - it isn't the same one it was!
+            i--; // be sure to check the current i again - it isn't the same one it was!
             break;
          }
          if(false_count == clause_size(c)) {
@@ -324,6 +897,7 @@ lit backtrack_once(solver* s){
    int i;
    clause* c;
 
+   if(s->gauss != 0) gauss_backtrack(s->gauss, s->cur_level);
    for(i = 0; i < s->size*2; i++){
       if(s->levels[i] == s->cur_level){
          s->assigns[i] = l_Undef;
@@ -358,6 +932,7 @@ bool backtrack(solver* s, lit* decision) {
    *decision = lit_neg(lev_choice);
    assert(s->decisions[lev_choice] == true);
    assert(s->decisions[lit_neg(lev_choice)] == false);
+   if(s->cur_level < s->proj_level) s->proj_level = -2; // back to deciding projection variables
    return true;
 }
 
@@ -383,25 +958,328 @@ bool find_unit(solver* s, lit* unit_lit){
 // returns false if conflict is found.  True if not, or solved.
 bool propagate_units(solver* s){
    lit unit_lit;
-   while(find_unit(s, &unit_lit)){
-      if(!propagate_decision(s,unit_lit,false)) return false; // CONFLICT
-      if(s->tail == 0) return true; // SATISFIED
+   veci implied;
+   bool solved, ok;
+   int i;
+
+   for(;;){
+      while(find_unit(s, &unit_lit)){
+         if(!propagate_decision(s,unit_lit,false)) return false; // CONFLICT
+         if(s->satisfied) return true; // SATISFIED
+      }
+      if(s->gauss == 0) return true;
+
+      // then the literals implied by the XOR constraints, and again until nothing new comes up
+      veci_new(&implied);
+      ok = gauss_propagate(s, &implied, &solved);
+      for(i = 0; ok && i < veci_size(&implied); i++)
+         ok = propagate_decision(s, veci_begin(&implied)[i], false);
+      veci_delete(&implied);
+      if(!ok) return false; // CONFLICT
+      if(i == 0) {
+         if(s->tail == 0 && solved) s->satisfied = true; // SATISFIED
+         return true;
+      }
    }
+}
+
+
+//=================================================================================================
+// Checkpointing:
+//
+// A snapshot holds the name of the input file and the complete search state: the clause database
+// in its current order (the working set and the satisfied clauses, with the level that satisfied
+// them), the XOR constraints, the trail (assignments, levels, decisions) and the enumeration
+// state. Resuming from it continues the search exactly where it stopped. Snapshots are only taken
+// between decisions, when nothing is half propagated.
+
+static const char snapshot_magic[8] = { 'S','S','A','T','C','K','P','3' };
+
+static bool write_snapshot(solver* s, FILE* f)
+{
+   int hdr[7], i, n;
+
+   hdr[0] = s->size;
+   hdr[1] = s->tail;
+   hdr[2] = s->cur_level;
+   hdr[3] = s->satisfied;
+   hdr[4] = s->enumerate;
+   hdr[5] = s->projected;
+   hdr[6] = s->proj_level;
+   fwrite(snapshot_magic, 1, sizeof(snapshot_magic), f);
+   fwrite(hdr, sizeof(int), 7, f);
+
+   n = s->input_file == 0 ? 0 : (int)strlen(s->input_file);
+   fwrite(&n, sizeof(int), 1, f);
+   fwrite(s->input_file, 1, n, f);
+
+   n = s->size*2;
+   fwrite(s->decisions,    sizeof(bool),  n, f);
+   fwrite(s->assigns,      sizeof(lbool), n, f);
+   fwrite(s->levels,       sizeof(int),   n, f);
+   fwrite(s->level_choice, sizeof(lit),   s->cur_level+1, f);
+   fwrite(s->proj,         sizeof(bool),  s->size, f);
+
+   n = veci_size(&s->nmodels);
+   fwrite(&n, sizeof(int), 1, f);
+   fwrite(veci_begin(&s->nmodels), sizeof(int), n, f);
+
+   n = vecp_size(&s->clauses);
+   fwrite(&n, sizeof(int), 1, f);
+   for (i = 0; i < n; i++){
+      clause* c = vecp_begin(&s->clauses)[i];
+      fwrite(c, sizeof(clause) + sizeof(lit)*clause_size(c), 1, f);
+   }
+
+   // XOR constraints (the matrix is rebuilt from them)
+   n = veci_size(&s->xor_ends);
+   fwrite(&n, sizeof(int), 1, f);
+   fwrite(veci_begin(&s->xor_ends), sizeof(int), n, f);
+   fwrite(veci_begin(&s->xor_rhs),  sizeof(int), n, f);
+   n = veci_size(&s->xor_vars);
+   fwrite(&n, sizeof(int), 1, f);
+   fwrite(veci_begin(&s->xor_vars), sizeof(int), n, f);
+   return !ferror(f);
+}
+
+// Writes the snapshot to a temporary file first, so an interrupted write never destroys the
+// previous snapshot.
+static bool checkpoint_write(solver* s)
+{
+   char* tmp = (char*)malloc(strlen(s->checkpoint_file) + 5);
+   FILE* f;
+   bool  ok;
+
+   sprintf(tmp, "%s.tmp", s->checkpoint_file);
+   f  = fopen(tmp, "wb");
+   ok = f != NULL && write_snapshot(s, f);
+   if (f != NULL) ok = (fclose(f) == 0) && ok;
+   ok = ok && rename(tmp, s->checkpoint_file) == 0;
+   if (!ok) fprintf(stderr, "WARNING! Could not write checkpoint: %s\n", s->checkpoint_file);
+   free(tmp);
+   return ok;
+}
+
+// Waits for the background writer (if any) to finish.
+static void checkpoint_wait(solver* s)
+{
+   if (s->checkpoint_pid > 0) waitpid(s->checkpoint_pid, 0, 0);
+   s->checkpoint_pid = 0;
+}
+
+// Writes a snapshot without stalling the search: a forked child writes its (copy-on-write) copy
+// of the state while the parent continues. Skipped if the previous writer is still busy.
+static void checkpoint_background(solver* s)
+{
+   pid_t pid;
+
+   if (s->checkpoint_pid > 0){
+      if (waitpid(s->checkpoint_pid, 0, WNOHANG) == 0) return; // still writing
+      s->checkpoint_pid = 0;
+   }
+   s->checkpoint_last = time(0);
+   pid = fork();
+   if (pid == 0)
+      _exit(checkpoint_write(s) ? 0 : 1); // _exit: the parent's stdio buffers are not ours to flush
+   else if (pid < 0)
+      checkpoint_write(s);                 // no fork: write it ourselves
+   else
+      s->checkpoint_pid = pid;
+}
+
+// Called between decisions. Returns false if the search should stop.
+static bool checkpoint_poll(solver* s)
+{
+   int req;
+
+   if (s->checkpoint_file == 0) return true;
+
+   if (s->checkpoint_request != 0 && (req = *s->checkpoint_request) != 0){
+      *s->checkpoint_request = 0;
+      if (req == ckpt_Stop){
+         checkpoint_wait(s);
+         checkpoint_write(s);
+         s->stopped = true;
+         return false;
+      }
+      checkpoint_background(s);
+   }
+   else if (s->checkpoint_every > 0 && (++s->checkpoint_ticks & 1023) == 0
+            && time(0) - s->checkpoint_last >= s->checkpoint_every)
+      checkpoint_background(s);
    return true;
 }
 
+// Reads a snapshot written by a checkpoint. Returns NULL if the file is missing or damaged.
+solver* solver_resume(const char* file)
+{
+   FILE*   f = fopen(file, "rb");
+   solver* s;
+   char    magic[sizeof(snapshot_magic)];
+   int     hdr[7], i, j, n;
+   bool    ok;
+
+   if (f == NULL) return 0;
+   s  = solver_new();
+   ok = fread(magic, 1, sizeof(magic), f) == sizeof(magic)
+     && memcmp(magic, snapshot_magic, sizeof(magic)) == 0
+     && fread(hdr, sizeof(int), 7, f) == 7
+     && hdr[0] >= 0 && hdr[2] >= -1 && hdr[2] < hdr[0]
+     && fread(&n, sizeof(int), 1, f) == 1 && n >= 0 && n < 1 << 20;
+
+   if (ok && n > 0){
+      s->input_file = (char*)malloc(n + 1);
+      ok = fread(s->input_file, 1, n, f) == (size_t)n;
+      s->input_file[n] = 0;
+   }
+
+   if (ok){
+      solver_setnvars(s, hdr[0]);
+      s->tail       = hdr[1];
+      s->cur_level  = hdr[2];
+      s->satisfied  = hdr[3];
+      s->enumerate  = hdr[4];
+      s->projected  = hdr[5];
+      s->proj_level = hdr[6];
+
+      n  = s->size*2;
+      ok = fread(s->decisions,    sizeof(bool),  n, f) == (size_t)n
+        && fread(s->assigns,      sizeof(lbool), n, f) == (size_t)n
+        && fread(s->levels,       sizeof(int),   n, f) == (size_t)n
+        && fread(s->level_choice, sizeof(lit),   s->cur_level+1, f) == (size_t)(s->cur_level+1)
+        && fread(s->proj,         sizeof(bool),  s->size, f) == (size_t)s->size
+        && fread(&n, sizeof(int), 1, f) == 1 && n >= 0;
+   }
+
+   for (i = 0; ok && i < n; i++){
+      veci_push(&s->nmodels, 0);
+      ok = fread(&veci_begin(&s->nmodels)[i], sizeof(int), 1, f) == 1;
+   }
+
+   ok = ok && fread(&n, sizeof(int), 1, f) == 1 && n >= s->tail && s->tail >= 0;
+   for (i = 0; ok && i < n; i++){
+      clause  hdr_c;
+      clause* c;
+      ok = fread(&hdr_c, sizeof(clause), 1, f) == 1 && hdr_c.size > 0;
+      if (!ok) break;
+      c  = (clause*)malloc(sizeof(clause) + sizeof(lit)*hdr_c.size);
+      *c = hdr_c;
+      vecp_push(&s->clauses, c);
+      ok = fread(c->lits, sizeof(lit), c->size, f) == (size_t)c->size;
+      for (j = 0; ok && j < c->size; j++)
+         ok = c->lits[j] >= 0 && c->lits[j] < s->size*2;
+   }
+
+   ok = ok && fread(&n, sizeof(int), 1, f) == 1 && n >= 0;
+   for (i = 0; ok && i < 2*n; i++){
+      ok = fread(&j, sizeof(int), 1, f) == 1;
+      veci_push(i < n ? &s->xor_ends : &s->xor_rhs, j);
+   }
+   ok = ok && fread(&n, sizeof(int), 1, f) == 1 && n >= 0
+      && (veci_size(&s->xor_ends) == 0 ? n == 0 : veci_begin(&s->xor_ends)[veci_size(&s->xor_ends)-1] == n);
+   for (i = 0; ok && i < n; i++){
+      ok = fread(&j, sizeof(int), 1, f) == 1 && j >= 0 && j < s->size;
+      veci_push(&s->xor_vars, j);
+   }
+   fclose(f);
+
+   if (!ok){
+      solver_delete(s);
+      return 0;
+   }
+   return s;
+}
+
+//=================================================================================================
+// Search:
+
+// Prints every total model extending the current (partial) one, restricted to the projection.
+static void printmodels(solver* s, veci* free_vars)
+{
+   int  k = veci_size(free_vars);
+   int* v = veci_begin(free_vars);
+   int  i;
+
+   for (i = 0; i < k; i++){
+      s->assigns[toLit(v[i])]          = l_False;
+      s->assigns[lit_neg(toLit(v[i]))] = l_True;
+   }
+   for (;;){
+      for (i = 0; i < s->size; i++)
+         if (s->proj[i])
+            fprintf(s->model_out, "x%d=%d ", i, s->assigns[toLit(i)] == l_True);
+      fprintf(s->model_out, "\n");
+
+      // binary increment over the free variables
+      for (i = 0; i < k && s->assigns[toLit(v[i])] == l_True; i++){
+         s->assigns[toLit(v[i])]          = l_False;
+         s->assigns[lit_neg(toLit(v[i]))] = l_True;
+      }
+      if (i == k) break;
+      s->assigns[toLit(v[i])]          = l_True;
+      s->assigns[lit_neg(toLit(v[i]))] = l_False;
+   }
+   for (i = 0; i < k; i++)
+      s->assigns[toLit(v[i])] = s->assigns[lit_neg(toLit(v[i]))] = l_Undef;
+}
+
+// Records the model just found and moves the search on to the next one. Returns false when the
+// search space is exhausted, otherwise 'decision' is the next (forced) decision.
+//
+// The DPLL search tree partitions the assignments, so no blocking clauses are needed: continuing
+// with chronological backtracking never finds the same model twice. A model is found as soon as
+// all clauses are satisfied, so it is a cube: every unassigned variable may take either value.
+static bool next_model(solver* s, lit* decision)
+{
+   veci free_vars;
+   int  i;
+
+   veci_new(&free_vars);
+   for (i = 0; i < s->size; i++)
+      if (s->proj[i] && s->assigns[toLit(i)] == l_Undef)
+         veci_push(&free_vars, i);
+   count_add_pow2(&s->nmodels, veci_size(&free_vars));
+   if (s->enumerate == enum_All)
+      printmodels(s, &free_vars);
+   veci_delete(&free_vars);
+   s->satisfied = false;
+
+   // Other models of the non-projection part have the same projection: skip them.
+   if (s->proj_level != -2){
+      while (s->cur_level > s->proj_level){
+         lit l = backtrack_once(s);
+         s->decisions[l] = s->decisions[lit_neg(l)] = false;
+      }
+      s->proj_level = -2;
+   }
+   if (s->cur_level < 0) return false;
+   return backtrack(s, decision);
+}
 
 bool solver_solve(solver* s){
    lit decision;
    bool forced = false;
 
+   if(s->gauss == 0 && veci_size(&s->xor_ends) > 0 && !gauss_init(s)) return false; // UNSATISFIABLE
+   if(s->tail == 0 && s->gauss == 0) s->satisfied = true; // no clauses at all
+
    while(true) {
+      if(s->interrupt && __atomic_load_n(s->interrupt, __ATOMIC_RELAXED))
+         return false; // someone else already knows the answer
+      if(s->satisfied) {
+         if(s->enumerate == enum_None) { checkpoint_wait(s); return true; }
+         if(!next_model(s, &decision)) break; // all models found
+         forced = true;
+      }
       // pick a variable to decide on (based on counts)
-      if(!forced) {decision = make_decision(s);}
+      if(!forced) {
+         if(!checkpoint_poll(s)) return false; // stopped, see s->stopped
+         decision = make_decision(s);
+      }
       else forced = false;
       if(!propagate_decision(s, decision, true)){
          // CONFLICT
-         if(!backtrack(s,&decision)) return false;//UNSATISFIABLE
+         if(!backtrack(s,&decision)) break;//UNSATISFIABLE (or no more models)
          else{ //Backtrack worked, decision must be forced
             forced = true;
             continue;
@@ -409,10 +1287,10 @@ bool solver_solve(solver* s){
       }
       else {
          // NO CONFLICT
-         if(s->satisfied) return true;
+         if(s->satisfied) continue;
          if(!propagate_units(s)){
             // CONFLICT
-            if(!backtrack(s, &decision)) return false; //UNSATISFIABLE
+            if(!backtrack(s, &decision)) break; //UNSATISFIABLE (or no more models)
             else {
                forced = true;
                continue;
@@ -420,11 +1298,394 @@ bool solver_solve(solver* s){
          }
          else {
             // NO CONFLICT
-            if(s->satisfied) return true;
+            if(s->satisfied) continue;
          }
       }
    }
-   return true;
+   checkpoint_wait(s);
+   s->satisfied = veci_size(&s->nmodels) > 0; // only ever true here when enumerating
+   return s->satisfied;
 }
 
 
+
+//=================================================================================================
+// Component decomposition:
+//
+// Formulas that are a union of variable-disjoint sub-problems are split into one sub-solver per
+// connected component (variables are connected if they share a clause). The components are solved
+// independently on a small pool of threads and their models are merged back into 's'. A conflict
+// in one component then never causes backtracking over decisions made in another.
+
+struct component_t
+{
+   solver* s;           // sub-solver holding only this component's clauses
+   veci    vars;        // vars[i] is the variable in the original solver for local variable i
+};
+typedef struct component_t component;
+
+struct pool_t
+{
+   pthread_mutex_t lock;
+   component*      comps;
+   int             ncomps;
+   int             next;        // next component to hand out
+   bool            unsat;       // set as soon as any component turns out UNSATISFIABLE. Other
+                                // threads read it with __atomic_load_n, so it is only
+                                // written with __atomic_store_n (under 'lock').
+};
+typedef struct pool_t pool;
+
+static int uf_find(int* parent, int v)
+{
+   while (parent[v] != v){
+      parent[v] = parent[parent[v]]; // path halving
+      v = parent[v];
+   }
+   return v;
+}
+
+static void uf_union(int* parent, int* rank, int a, int b)
+{
+   a = uf_find(parent, a);
+   b = uf_find(parent, b);
+   if (a == b) return;
+   if (rank[a] < rank[b]) { int t = a; a = b; b = t; }
+   parent[b] = a;
+   if (rank[a] == rank[b]) rank[a]++;
+}
+
+// largest components first, so the long ones do not end up starting last
+static int component_cmp(const void* x, const void* y)
+{
+   return ((const component*)y)->s->tail - ((const component*)x)->s->tail;
+}
+
+static void* component_worker(void* arg)
+{
+   pool* p = (pool*)arg;
+   int i;
+
+   for (;;){
+      pthread_mutex_lock(&p->lock);
+      i = p->unsat ? p->ncomps : p->next++;
+      pthread_mutex_unlock(&p->lock);
+      if (i >= p->ncomps) break;
+
+      if (!solver_solve(p->comps[i].s)){
+         // the other workers notice through their 'interrupt' pointer
+         pthread_mutex_lock(&p->lock);
+         __atomic_store_n(&p->unsat, true, __ATOMIC_RELAXED);
+         pthread_mutex_unlock(&p->lock);
+      }
+   }
+   return 0;
+}
+
+// Same result as solver_solve(), but independent components are solved separately on up to
+// 'nthreads' threads. Returns false (UNSATISFIABLE) as soon as one component is UNSATISFIABLE.
+bool solver_solve_components(solver* s, int nthreads)
+{
+   int*       parent;
+   int*       rank;
+   int*       comp_of;   // component index of each variable's root, or -1
+   int*       local;     // local variable index of each variable inside its component
+   component* comps;
+   pthread_t* threads;
+   pool       p;
+   veci       lits;
+   clause*    c;
+   int*       xvars = veci_begin(&s->xor_vars);
+   int*       xends = veci_begin(&s->xor_ends);
+   int        nxors = veci_size(&s->xor_ends);
+   int        ncomps, nstarted, i, j, v;
+
+   if (vecp_size(&s->clauses) == 0) return solver_solve(s);
+
+   parent  = (int*)malloc(sizeof(int)*s->size);
+   rank    = (int*)malloc(sizeof(int)*s->size);
+   comp_of = (int*)malloc(sizeof(int)*s->size);
+   local   = (int*)malloc(sizeof(int)*s->size);
+   for (v = 0; v < s->size; v++){
+      parent[v]  = v;
+      rank[v]    = 0;
+      comp_of[v] = -1;
+   }
+
+   for (i = 0; i < vecp_size(&s->clauses); i++){
+      c = vecp_begin(&s->clauses)[i];
+      for (j = 1; j < clause_size(c); j++)
+         uf_union(parent, rank, lit_var(c->lits[0]), lit_var(c->lits[j]));
+   }
+   for (i = 0; i < nxors; i++)
+      for (j = (i == 0 ? 0 : xends[i-1]) + 1; j < xends[i]; j++)
+         uf_union(parent, rank, xvars[j-1], xvars[j]);
+
+   // number the components (only variables that occur in some constraint belong to one)
+   ncomps = 0;
+   for (i = 0; i < vecp_size(&s->clauses); i++){
+      c = vecp_begin(&s->clauses)[i];
+      v = uf_find(parent, lit_var(c->lits[0]));
+      if (comp_of[v] == -1) comp_of[v] = ncomps++;
+   }
+   for (i = 0; i < nxors; i++){
+      v = uf_find(parent, xvars[i == 0 ? 0 : xends[i-1]]);
+      if (comp_of[v] == -1) comp_of[v] = ncomps++;
+   }
+
+   if (ncomps <= 1){
+      free(parent); free(rank); free(comp_of); free(local);
+      return solver_solve(s);
+   }
+
+   comps = (component*)malloc(sizeof(component)*ncomps);
+   for (i = 0; i < ncomps; i++){
+      comps[i].s = solver_new();
+      veci_new(&comps[i].vars);
+   }
+
+   for (v = 0; v < s->size; v++){
+      int root = uf_find(parent, v);
+      if (comp_of[root] == -1) continue; // variable occurs in no constraint
+      local[v] = veci_size(&comps[comp_of[root]].vars);
+      veci_push(&comps[comp_of[root]].vars, v);
+   }
+
+   veci_new(&lits);
+   for (i = 0; i < vecp_size(&s->clauses); i++){
+      component* k;
+      c = vecp_begin(&s->clauses)[i];
+      k = &comps[comp_of[uf_find(parent, lit_var(c->lits[0]))]];
+      veci_resize(&lits, 0);
+      for (j = 0; j < clause_size(c); j++){
+         lit l = toLit(local[lit_var(c->lits[j])]);
+         veci_push(&lits, lit_sign(c->lits[j]) ? lit_neg(l) : l);
+      }
+      solver_addclause(k->s, veci_begin(&lits), veci_begin(&lits) + veci_size(&lits));
+   }
+   for (i = 0; i < nxors; i++){
+      int first = i == 0 ? 0 : xends[i-1];
+      component* k = &comps[comp_of[uf_find(parent, xvars[first])]];
+      veci_resize(&lits, 0);
+      for (j = first; j < xends[i]; j++)
+         veci_push(&lits, toLit(local[xvars[j]]));
+      if (veci_begin(&s->xor_rhs)[i] == 0)   // positive literals XOR to 1, so flip one for 0
+         veci_begin(&lits)[0] = lit_neg(veci_begin(&lits)[0]);
+      solver_addxor(k->s, veci_begin(&lits), veci_begin(&lits) + veci_size(&lits));
+   }
+   veci_delete(&lits);
+   free(parent); free(rank); free(comp_of); free(local);
+
+   qsort(comps, ncomps, sizeof(component), component_cmp);
+
+   // solve: the calling thread is one of the workers
+   pthread_mutex_init(&p.lock, 0);
+   p.comps  = comps;
+   p.ncomps = ncomps;
+   p.next   = 0;
+   p.unsat  = false;
+   for (i = 0; i < ncomps; i++)
+      comps[i].s->interrupt = &p.unsat;
+
+   if (nthreads > ncomps) nthreads = ncomps;
+   if (nthreads < 1)      nthreads = 1;
+   threads  = (pthread_t*)malloc(sizeof(pthread_t)*nthreads);
+   nstarted = 0;
+   for (i = 1; i < nthreads; i++)
+      if (pthread_create(&threads[nstarted], 0, component_worker, &p) == 0)
+         nstarted++;
+   component_worker(&p);
+   for (i = 0; i < nstarted; i++)
+      pthread_join(threads[i], 0);
+   free(threads);
+   pthread_mutex_destroy(&p.lock);
+
+   // merge the models
+   if (!p.unsat){
+      for (i = 0; i < ncomps; i++){
+         for (j = 0; j < veci_size(&comps[i].vars); j++){
+            lit l = toLit(veci_begin(&comps[i].vars)[j]);
+            s->assigns[l]          = comps[i].s->assigns[toLit(j)];
+            s->assigns[lit_neg(l)] = comps[i].s->assigns[lit_neg(toLit(j))];
+         }
+      }
+      s->satisfied = true;
+   }
+
+   for (i = 0; i < ncomps; i++){
+      solver_delete(comps[i].s);
+      veci_delete(&comps[i].vars);
+   }
+   free(comps);
+
+   return !p.unsat;
+}
+
+//=================================================================================================
+// Model verification:
+//
+// The original clauses are kept in a flat array (all literals back to back, plus the end of each
+// clause), independent of whatever the search does to its own clause database. Checking a model
+// first gathers the truth values of a block of literals into a small buffer, then scans each
+// clause of the block for a true literal. The gather dominates and is memory bound, so large
+// formulas are split over several threads.
+
+#define VERIFY_BLOCK      4096        // literals gathered at a time
+#define VERIFY_PER_THREAD (1 << 20)   // don't start a thread for fewer literals than this
+
+struct verify_job_t
+{
+   solver*        s;
+   unsigned char* val;      // val[l] is 1 if literal l is true in the model
+   int            from, to; // clauses to check
+   int            maxlen;   // longest clause
+   int            bad;      // first falsified clause in [from, to), or -1
+};
+typedef struct verify_job_t verify_job;
+
+// Keeps a copy of the clauses for solver_verify(): of those already added, and of all later ones.
+void solver_keeporiginal(solver* s)
+{
+   int i, j;
+
+   if (s->keep_original) return;
+   s->keep_original = true;
+   for (i = 0; i < vecp_size(&s->clauses); i++){
+      clause* c = vecp_begin(&s->clauses)[i];
+      for (j = 0; j < clause_size(c); j++)
+         veci_push(&s->orig_lits, c->lits[j]);
+      veci_push(&s->orig_ends, veci_size(&s->orig_lits));
+   }
+}
+
+static void* verify_worker(void* arg)
+{
+   verify_job*    job  = (verify_job*)arg;
+   int*           lits = veci_begin(&job->s->orig_lits);
+   int*           ends = veci_begin(&job->s->orig_ends);
+   unsigned char* buf  = (unsigned char*)malloc(VERIFY_BLOCK > job->maxlen ? VERIFY_BLOCK : job->maxlen);
+   int            k    = job->from;
+
+   job->bad = -1;
+   while (k < job->to){
+      int begin = k == 0 ? 0 : ends[k-1];
+      int last  = k + 1;          // the block is clauses [k, last), at least one
+      int n, i;
+
+      while (last < job->to && ends[last] - begin <= VERIFY_BLOCK) last++;
+      n = ends[last-1] - begin;
+
+      // gather: random reads into 'val', so this is bound by memory, not by arithmetic
+      for (i = 0; i < n; i++)
+         buf[i] = job->val[lits[begin + i]];
+
+      for (i = 0; k < last; k++){
+         unsigned char sat = 0;
+         for (; i < ends[k] - begin; i++)
+            sat |= buf[i];
+         if (!sat){
+            job->bad = k;
+            free(buf);
+            return 0;
+         }
+      }
+   }
+   free(buf);
+   return 0;
+}
+
+// Checks the model printed by printsolution() against every original clause (see
+// solver_keeporiginal()), using up to 'nthreads' threads, and against the XOR constraints.
+// Returns the index of the first constraint that is not satisfied (clauses first, then XOR
+// constraints), or -1 if the model is correct.
+int solver_verify(solver* s, int nthreads)
+{
+   int            nclauses = veci_size(&s->orig_ends);
+   int            nlits    = veci_size(&s->orig_lits);
+   int*           ends     = veci_begin(&s->orig_ends);
+   unsigned char* val      = (unsigned char*)malloc(s->size*2 + 1);
+   verify_job*    jobs;
+   pthread_t*     threads;
+   bool*          started;
+   int            maxlen, bad, i, v;
+
+   assert(s->keep_original);
+
+   // unassigned variables are printed as true
+   for (v = 0; v < s->size; v++){
+      val[toLit(v)]          = s->assigns[toLit(v)] != l_False;
+      val[lit_neg(toLit(v))] = !val[toLit(v)];
+   }
+
+   maxlen = 0;
+   for (i = 0; i < nclauses; i++){
+      int len = ends[i] - (i == 0 ? 0 : ends[i-1]);
+      if (len > maxlen) maxlen = len;
+   }
+
+   if (nthreads > nlits / VERIFY_PER_THREAD) nthreads = nlits / VERIFY_PER_THREAD;
+   if (nthreads < 1) nthreads = 1;
+   jobs    = (verify_job*)malloc(sizeof(verify_job)*nthreads);
+   threads = (pthread_t*) malloc(sizeof(pthread_t)*nthreads);
+   started = (bool*)      malloc(sizeof(bool)*nthreads);
+
+   // give every thread about the same number of literals
+   for (i = 0; i < nthreads; i++){
+      jobs[i].s      = s;
+      jobs[i].val    = val;
+      jobs[i].maxlen = maxlen;
+      jobs[i].from   = i == 0 ? 0 : jobs[i-1].to;
+      jobs[i].to     = jobs[i].from;
+      while (jobs[i].to < nclauses && ends[jobs[i].to] <= (long long)nlits * (i+1) / nthreads)
+         jobs[i].to++;
+      if (i == nthreads-1) jobs[i].to = nclauses;
+   }
+
+   for (i = 1; i < nthreads; i++)
+      started[i] = pthread_create(&threads[i], 0, verify_worker, &jobs[i]) == 0;
+   verify_worker(&jobs[0]);
+   for (i = 1; i < nthreads; i++){
+      if (started[i]) pthread_join(threads[i], 0);
+      else            verify_worker(&jobs[i]);
+   }
+
+   bad = -1;
+   for (i = 0; i < nthreads && bad == -1; i++)
+      bad = jobs[i].bad;
+
+   // the XOR constraints are never changed, so they are checked as they are
+   for (i = 0; bad == -1 && i < veci_size(&s->xor_ends); i++){
+      int parity = 0;
+      for (v = i == 0 ? 0 : veci_begin(&s->xor_ends)[i-1]; v < veci_begin(&s->xor_ends)[i]; v++)
+         parity ^= val[toLit(veci_begin(&s->xor_vars)[v])];
+      if (parity != veci_begin(&s->xor_rhs)[i]) bad = nclauses + i;
+   }
+
+   free(val);
+   free(jobs);
+   free(threads);
+   free(started);
+   return bad;
+}
+
+// Prints original constraint 'i' (numbered as by solver_verify()) in DIMACS form.
+void printoriginal(solver* s, int i, FILE* out)
+{
+   int  nclauses = veci_size(&s->orig_ends);
+   int  j;
+   int* lits = veci_begin(&s->orig_lits);
+   int* vars = veci_begin(&s->xor_vars);
+
+   if (i < nclauses){
+      for (j = i == 0 ? 0 : veci_begin(&s->orig_ends)[i-1]; j < veci_begin(&s->orig_ends)[i]; j++)
+         fprintf(out, "%s%d ", lit_sign(lits[j]) ? "-" : "", lit_var(lits[j]) + 1);
+   }
+   else {
+      i -= nclauses;
+      j  = i == 0 ? 0 : veci_begin(&s->xor_ends)[i-1];
+      fprintf(out, "x%s%d ", veci_begin(&s->xor_rhs)[i] ? "" : "-", vars[j] + 1);
+      for (j++; j < veci_begin(&s->xor_ends)[i]; j++)
+         fprintf(out, "%d ", vars[j] + 1);
+   }
+   fprintf(out, "0");
+}
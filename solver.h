@@ -24,6 +24,9 @@ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWA
 
 #include "vec.h"
 #include <stdio.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/types.h>
 //================================================================================================
 // Simple types:
 
@@ -39,6 +42,15 @@ static const lbool l_Undef   =  0;
 static const lbool l_True    =  1;
 static const lbool l_False   = -1;
 
+// model enumeration modes (solver_t.enumerate)
+static const int enum_None   = 0;   // stop at the first model
+static const int enum_All    = 1;   // print every model to 'model_out' as it is found
+static const int enum_Count  = 2;   // only count the models
+
+// checkpoint requests (*solver_t.checkpoint_request)
+static const int ckpt_Save   = 1;   // write a snapshot and continue
+static const int ckpt_Stop   = 2;   // write a snapshot and stop the search
+
 
 static inline lit  toLit   (int v) { return v + v; } // changes value to literal int (other than sign bit)
 static inline lit  lit_neg (lit l) { return l ^ 1; } // Changes the sign of the lit
@@ -53,13 +65,22 @@ struct solver_t;
 typedef struct solver_t solver;
 
 extern bool    solver_solve(solver* s);
+extern bool    solver_solve_components(solver* s, int nthreads);
 extern void    printsolution(solver* s, FILE* out);
+extern void    printcount(solver* s, FILE* out);
+extern bool    solver_project(solver* s, int var);
+extern void    solver_keeporiginal(solver* s);
+extern int     solver_verify(solver* s, int nthreads);
+extern void    printoriginal(solver* s, int i, FILE* out);
 extern solver* solver_new(void);
+extern solver* solver_resume(const char* file);
 extern void    solver_delete(solver* s);
 
 extern void    printsolver(solver* s);
 extern void    printclauses(solver* s);
 extern bool    solver_addclause(solver* s, lit* begin, lit* end);
+extern bool    solver_addxor(solver* s, lit* begin, lit* end);
+extern int     solver_findxors(solver* s);
 
 extern void    solver_setnvars(solver* s,int n);
 
@@ -70,6 +91,9 @@ extern void    solver_setnvars(solver* s,int n);
 struct clause_t;
 typedef struct clause_t clause;
 
+struct gauss_t;
+typedef struct gauss_t gauss;
+
 struct solver_t
 {
    int size;            // number of variables
@@ -90,6 +114,39 @@ struct solver_t
    int*  levels;        // level that each lit was assigned
    int*  counts;        // number of occurrences of each literal
 
+   bool*  interrupt;    // if set, solver_solve() gives up (returns false) once *interrupt
+                        // becomes true (read atomically). Stops the other components early.
+
+   // Model enumeration:
+   int    enumerate;    // one of enum_None, enum_All, enum_Count
+   FILE*  model_out;    // models are streamed here in enum_All mode
+   bool   projected;    // true if enumeration is restricted to a subset of the variables
+   bool*  proj;         // proj[var] is true if var is in that subset (all variables by default)
+   int    proj_level;   // level of the last decision on a projection variable, once the search
+                        // has moved on to the other variables. -2 otherwise.
+   veci   nmodels;      // number of models found, as little-endian 32-bit words
+
+   // Checkpointing (snapshots of the search that solver_resume() continues from):
+   const char*   checkpoint_file;     // where snapshots go. No checkpointing if NULL.
+   int           checkpoint_every;    // seconds between periodic snapshots (0 = never)
+   volatile sig_atomic_t* checkpoint_request; // set asynchronously (typically by a signal
+                                      // handler) to ckpt_Save or ckpt_Stop
+   time_t        checkpoint_last;     // time of the last snapshot
+   int           checkpoint_ticks;    // decisions since the clock was last looked at
+   pid_t         checkpoint_pid;      // process writing a snapshot in the background, or 0
+   bool          stopped;             // true if solver_solve() returned because of ckpt_Stop
+   char*         input_file;          // name of the problem, kept in snapshots (malloc'ed, or NULL)
+
+   // Original clauses, for solver_verify():
+   bool   keep_original; // true if clauses are copied to the arrays below
+   veci   orig_lits;    // literals of all clauses, back to back
+   veci   orig_ends;    // orig_ends[i] is where clause i ends in orig_lits
+
+   // XOR constraints (variables only, negations are folded into the parity):
+   veci   xor_vars;     // variables of all XOR constraints, back to back
+   veci   xor_ends;     // xor_ends[i] is where constraint i ends in xor_vars
+   veci   xor_rhs;      // xor_rhs[i] is the parity the variables of constraint i must add up to
+   gauss* gauss;        // Gauss-Jordan elimination matrix over all of them (NULL if none)
 };
 
 